@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <chrono>
+#include <print>
+#include <spawn.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+// Spawns binary with --once and measures time until first byte appears on its stdout
+static std::chrono::nanoseconds measure_first_byte(const std::string &binary) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        throw std::runtime_error("pipe failed");
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_addclose(&actions, fds[1]);
+
+    std::string once = "--once";
+    char *argv[] = {const_cast<char *>(binary.c_str()), once.data(), nullptr};
+
+    auto const start = std::chrono::steady_clock::now();
+
+    pid_t pid;
+    int spawned = posix_spawn(&pid, binary.c_str(), &actions, nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+
+    if (spawned != 0) {
+        close(fds[0]);
+        throw std::runtime_error("failed to spawn " + binary);
+    }
+
+    char buffer[4096];
+    ssize_t n = read(fds[0], buffer, 1);
+    auto const first_byte = std::chrono::steady_clock::now();
+
+    while (n > 0) {
+        n = read(fds[0], buffer, sizeof(buffer));
+    }
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        throw std::runtime_error(binary + " exited with failure");
+    }
+
+    return first_byte - start;
+}
+
+static double to_microseconds(std::chrono::nanoseconds ns) {
+    return std::chrono::duration<double, std::micro>(ns).count();
+}
+
+int main(int argc, char **argv) {
+    int iterations = 100;
+    std::vector<std::string> binaries;
+
+    for (int it = 1; it < argc; ++it) {
+        std::string_view arg = argv[it];
+        if (arg == "-n" && it + 1 < argc) {
+            iterations = std::max(std::stoi(argv[++it]), 1);
+        } else {
+            binaries.emplace_back(arg);
+        }
+    }
+
+    if (binaries.empty()) {
+        std::println("usage: {} [-n iterations] binary...", argv[0]);
+        return 1;
+    }
+
+    for (const auto &binary: binaries) {
+        // warm up page cache and dynamic loader
+        measure_first_byte(binary);
+
+        std::vector<std::chrono::nanoseconds> samples;
+        samples.reserve(iterations);
+        for (int it = 0; it < iterations; ++it) {
+            samples.push_back(measure_first_byte(binary));
+        }
+
+        std::ranges::sort(samples);
+        std::println("{}: min {:.0f} us | median {:.0f} us | p95 {:.0f} us ({} runs)",
+                     binary,
+                     to_microseconds(samples.front()),
+                     to_microseconds(samples[samples.size() / 2]),
+                     to_microseconds(samples[samples.size() * 95 / 100]),
+                     iterations);
+    }
+
+    return 0;
+}
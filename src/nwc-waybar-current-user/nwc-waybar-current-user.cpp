@@ -1,15 +1,17 @@
+#include <algorithm>
 #include <chrono>
-#include <iostream>
+#include <cstdio>
 #include <unistd.h>
 #include <pwd.h>
 #include <string>
 #include <print>
 #include <systemd/sd-login.h>
 #include <boost/json.hpp>
+#include <boost/json/src.hpp>
 #include <fmt/base.h>
 #include <fmt/format.h>
 #include <fmt/chrono.h>
-#include <sys/sysinfo.h>
+#include <ctime>
 
 #include "../nwc/arguments.hpp"
 #include "../nwc/fmt-map.hpp"
@@ -21,9 +23,16 @@ namespace json = boost::json;
 
 static bool arg_uptime_dynamic{};
 static bool arg_boot_time_dynamic{};
+static bool arg_sync_to_change{};
 
 static std::optional<std::chrono::system_clock::time_point> state_uptime_start;
 
+struct user_entry {
+    std::string name{}, full_name{};
+};
+
+static std::optional<user_entry> state_user;
+
 static std::chrono::system_clock::time_point get_user_start_date() {
     if (state_uptime_start) {
         return *state_uptime_start;
@@ -73,12 +82,7 @@ static std::string resolve_uptime() {
 }
 
 static std::string resolve_boottime() {
-    struct sysinfo info = {};
-    if (sysinfo(&info) != 0) {
-        throw std::runtime_error("sysinfo failed");
-    }
-
-    std::chrono::seconds boot_time(info.uptime);
+    auto boot_time = std::chrono::duration_cast<std::chrono::seconds>(nwc::clock_now(CLOCK_BOOTTIME));
     if (arg_boot_time_dynamic) {
         return nwc::duration_to_string(boot_time, true);
     }
@@ -86,22 +90,54 @@ static std::string resolve_boottime() {
     return nwc::duration_to_string(boot_time);
 }
 
-static std::string resolve_user_name() {
+static const user_entry &get_user_entry() {
+    if (state_user) {
+        return *state_user;
+    }
+
     auto const e = geteuid();
     auto const *pw = getpwuid(e);
-    return pw ? pw->pw_name : "";
+
+    state_user = pw ? user_entry{pw->pw_name, pw->pw_gecos} : user_entry{};
+    return *state_user;
+}
+
+static std::string resolve_user_name() {
+    return get_user_entry().name;
 }
 
 static std::string resolve_user_full_name() {
-    auto const e = geteuid();
-    auto const *pw = getpwuid(e);
-    return pw ? pw->pw_gecos : "";
+    return get_user_entry().full_name;
 }
 
 static std::string resolve_user_icon() {
     return "\uf007";
 }
 
+// Time left until displayed uptime changes, uptime is measured on wall clock from session start
+static std::chrono::nanoseconds until_uptime_change() {
+    auto const now = std::chrono::system_clock::now();
+    auto const user_start_date = get_user_start_date();
+    auto const uptime = std::chrono::duration_cast<std::chrono::seconds>(now - user_start_date);
+    auto const change = user_start_date + uptime + nwc::duration_to_string_next_change(uptime, arg_uptime_dynamic);
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(change - now);
+}
+
+// Sleeps until uptime or boot time text changes. Whole sleep is done on CLOCK_BOOTTIME, so stepping
+// wall clock (e.g. NTP sync after login) can't stretch it, and it's capped in case the step happened
+// between reading wall clock and going to sleep.
+static void sleep_until_visible_change() {
+    constexpr auto max_sleep = std::chrono::seconds{60};
+
+    auto const boot_now = nwc::clock_now(CLOCK_BOOTTIME);
+    auto const boot_time = std::chrono::duration_cast<std::chrono::seconds>(boot_now);
+    auto const boottime_change = boot_time + nwc::duration_to_string_next_change(boot_time, arg_boot_time_dynamic);
+
+    auto const deadline = std::min<std::chrono::nanoseconds>({boottime_change, boot_now + until_uptime_change(), boot_now + max_sleep});
+    nwc::sleep_until(CLOCK_BOOTTIME, deadline);
+}
+
 int main(int argc, char **argv) {
     nwc::arguments args{
         "{icon} {name} {uptime}",
@@ -121,7 +157,9 @@ int main(int argc, char **argv) {
     ("uptime-dynamic", po::value(&arg_uptime_dynamic)->default_value(true),
      "dynamically adapt time format for displaying uptime")
     ("dynamic-boot-time", po::value(&arg_boot_time_dynamic)->default_value(true),
-     "dynamically adapt time format for displaying boot time");
+     "dynamically adapt time format for displaying boot time")
+    ("sync-to-change", po::value(&arg_sync_to_change)->default_value(true),
+     "sleep until displayed text changes instead of for interval");
 
 
     args.parse(argc, argv);
@@ -139,10 +177,14 @@ int main(int argc, char **argv) {
         };
 
         std::println("{}", serialize(line));
-        std::flush(std::cout);
+        std::fflush(stdout);
 
         if (args.indefinite()) {
-            nwc::sleep(args.sleep_for());
+            if (arg_sync_to_change) {
+                sleep_until_visible_change();
+            } else {
+                nwc::sleep(args.sleep_for());
+            }
         }
     } while (args.indefinite());
 
@@ -0,0 +1,193 @@
+#include "./icon-map.hpp"
+
+#include <array>
+#include <fstream>
+#include <stdexcept>
+
+namespace nwc {
+    namespace {
+        struct icon_entry {
+            std::string_view name;
+            std::string_view icon;
+        };
+
+        constexpr auto builtin_icons = std::to_array<icon_entry>({
+            {"firefox", "\uf269"},
+            {"firefox-bin", "\uf269"},
+            {"webstorm", "\uf121"},
+            {"clion", "\ue61d"},
+            {"clangd", "\ue61d"},
+            {"Rider.Backend", "\uf121"},
+            {"systemd", "\uf4fe"},
+            {"systemd-journald", "\uf4fe"},
+            {"sddm", "\uf390"},
+            {"sddm-helper", "\uf390"},
+            {"Hyprland", "\uf359"},
+            {"xdg-desktop-portal-hyprland", "\uf359"},
+            {"hyprpaper", "\uf359"},
+            {"waybar", "\uf2d1"},
+            {"bash", "\uf120"},
+            {"sh", "\uf120"},
+            {"kitty", "\uf6be"},
+            {"dropbox", "\ue707"},
+            {"dockerd", "\ue7b0"},
+            {"containerd", "\ue7b0"},
+            {"keepassxc", "\uf033e"},
+            {"nodejs", "\ued0d"},
+            {"pnpm", "\ue865"},
+            {"Xorg", "\uf369"},
+            {"python", "\ue73c"},
+            {"python3", "\ue73c"},
+            {"nm-applet", "\uef09"},
+        });
+
+        // FNV-1a with a splitmix64 finalizer, so every input bit reaches the low bits used for the slot index
+        constexpr std::uint64_t hash_name(std::string_view name, std::uint64_t seed = 0) noexcept {
+            std::uint64_t hash = 0xcbf29ce484222325ULL ^ seed;
+            for (const char c: name) {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 0x100000001b3ULL;
+            }
+
+            hash ^= hash >> 30;
+            hash *= 0xbf58476d1ce4e5b9ULL;
+            hash ^= hash >> 27;
+            hash *= 0x94d049bb133111ebULL;
+            hash ^= hash >> 31;
+            return hash;
+        }
+
+        constexpr std::size_t builtin_slot_count = 128;
+        constexpr std::uint8_t builtin_empty_slot = 0xff;
+
+        static_assert((builtin_slot_count & (builtin_slot_count - 1)) == 0, "slot count must be power of two");
+        static_assert(builtin_icons.size() < builtin_empty_slot, "too many builtin icons for 8-bit slots");
+
+        struct perfect_table {
+            std::uint64_t seed{};
+            std::array<std::uint8_t, builtin_slot_count> slots{};
+        };
+
+        // Searches for a seed under which every built-in name lands in its own slot
+        consteval perfect_table build_perfect_table() {
+            for (std::uint64_t seed = 0; seed < 100000; ++seed) {
+                perfect_table table{seed, {}};
+                table.slots.fill(builtin_empty_slot);
+
+                bool collision = false;
+                for (std::size_t i = 0; i < builtin_icons.size() && !collision; ++i) {
+                    auto &slot = table.slots[hash_name(builtin_icons[i].name, seed) & (builtin_slot_count - 1)];
+                    if (slot != builtin_empty_slot) {
+                        collision = true;
+                    } else {
+                        slot = static_cast<std::uint8_t>(i);
+                    }
+                }
+
+                if (!collision) {
+                    return table;
+                }
+            }
+
+            throw std::logic_error("no perfect hash seed for builtin icon table");
+        }
+
+        constexpr perfect_table builtin_table = build_perfect_table();
+
+        constexpr std::optional<std::string_view> lookup_builtin(std::string_view name) noexcept {
+            const auto index = builtin_table.slots[hash_name(name, builtin_table.seed) & (builtin_slot_count - 1)];
+            if (index == builtin_empty_slot || builtin_icons[index].name != name) {
+                return std::nullopt;
+            }
+
+            return builtin_icons[index].icon;
+        }
+
+        static_assert(lookup_builtin("firefox") == "\uf269");
+        static_assert(lookup_builtin("sh") == "\uf120");
+        static_assert(!lookup_builtin("not-a-process"));
+    }
+
+    void icon_map::load(const std::string &path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open icon map: " + path);
+        }
+
+        std::string line;
+        while (std::getline(file, line)) {
+            const std::string_view view = line;
+
+            const auto name_start = view.find_first_not_of(" \t");
+            if (name_start == std::string_view::npos || view[name_start] == '#') {
+                continue;
+            }
+
+            const auto name_end = view.find_first_of(" \t", name_start);
+            if (name_end == std::string_view::npos) {
+                continue;
+            }
+
+            const auto icon_start = view.find_first_not_of(" \t", name_end);
+            if (icon_start == std::string_view::npos) {
+                continue;
+            }
+
+            const auto icon_end = view.find_last_not_of(" \t\r");
+            insert(view.substr(name_start, name_end - name_start), view.substr(icon_start, icon_end - icon_start + 1));
+        }
+    }
+
+    std::optional<std::string_view> icon_map::find(std::string_view name) const noexcept {
+        if (size_ > 0 && !name.empty()) {
+            const auto hash = hash_name(name);
+            const auto mask = slots_.size() - 1;
+
+            for (auto index = hash & mask; !slots_[index].name.empty(); index = (index + 1) & mask) {
+                if (slots_[index].hash == hash && slots_[index].name == name) {
+                    return slots_[index].icon;
+                }
+            }
+        }
+
+        return lookup_builtin(name);
+    }
+
+    void icon_map::insert(std::string_view name, std::string_view icon) {
+        if ((size_ + 1) * 2 > slots_.size()) {
+            grow();
+        }
+
+        const auto hash = hash_name(name);
+        const auto mask = slots_.size() - 1;
+
+        auto index = hash & mask;
+        for (; !slots_[index].name.empty(); index = (index + 1) & mask) {
+            if (slots_[index].hash == hash && slots_[index].name == name) {
+                slots_[index].icon = icon;
+                return;
+            }
+        }
+
+        slots_[index] = slot{hash, std::string{name}, std::string{icon}};
+        size_++;
+    }
+
+    void icon_map::grow() {
+        std::vector<slot> old = std::move(slots_);
+        slots_ = std::vector<slot>(old.empty() ? 16 : old.size() * 2);
+
+        const auto mask = slots_.size() - 1;
+        for (auto &entry: old) {
+            if (entry.name.empty()) {
+                continue;
+            }
+
+            auto index = entry.hash & mask;
+            while (!slots_[index].name.empty()) {
+                index = (index + 1) & mask;
+            }
+            slots_[index] = std::move(entry);
+        }
+    }
+}
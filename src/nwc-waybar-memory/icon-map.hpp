@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nwc {
+    // Lookup from process name to icon glyph.
+    //
+    // Built-in icons live in a compile time perfect hash table, user supplied icons (if any) are
+    // loaded once into a flat open addressing table and take precedence over built-in ones.
+    class icon_map {
+    public:
+        icon_map() = default;
+        ~icon_map() = default;
+
+        // Loads icons from file, one "name icon" pair per line, lines starting with '#' are ignored.
+        void load(const std::string &path);
+
+        [[nodiscard]] std::optional<std::string_view> find(std::string_view name) const noexcept;
+
+    private:
+        struct slot {
+            std::uint64_t hash{};
+            std::string name{}, icon{};
+        };
+
+        std::vector<slot> slots_;
+        std::size_t size_ = 0;
+
+        void insert(std::string_view name, std::string_view icon);
+        void grow();
+    };
+}
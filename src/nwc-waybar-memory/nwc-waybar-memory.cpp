@@ -1,17 +1,44 @@
+#include <cstdio>
 #include <fstream>
 #include <format>
-#include <iostream>
 #include <print>
 #include <boost/json.hpp>
+#include <boost/json/src.hpp>
 #include <filesystem>
+#include <unordered_map>
 
 #include "../nwc/arguments.hpp"
 #include "../nwc/utility.hpp"
+#include "./icon-map.hpp"
+#include "./state-cache.hpp"
 
 static int top_process_count = 15;
 static int top_group_count = 15;
 
+// process list is scanned every this many iterations
+constexpr unsigned process_list_refresh_period = 15;
+static std::string icon_map_path{};
+static nwc::icon_map icons;
+
+enum class memory_metric {
+    rss,
+    pss,
+    uss,
+};
+
+static std::string metric_name = "rss";
+static memory_metric metric = memory_metric::rss;
+static int metric_refresh = 4;
+
+static bool use_state_cache{};
+static std::string state_path{};
+
+static bool use_numa{};
+
 void loop();
+memory_metric parse_memory_metric(std::string_view name);
+void restore_process_list();
+void detect_numa_nodes();
 
 int main(int argc, char **argv) {
     using namespace boost::program_options;
@@ -23,7 +50,17 @@ int main(int argc, char **argv) {
     ("top-process-count,p", value(&top_process_count)->default_value(15),
      "how many process should be displayed")
     ("top-group-count,g", value(&top_group_count)->default_value(15),
-     "how many process should be displayed");
+     "how many process should be displayed")
+    ("icon-map", value(&icon_map_path),
+     "file with additional \"name icon\" pairs used for process icons")
+    ("metric,m", value(&metric_name)->default_value("rss"),
+     "memory metric used for processes: rss, pss or uss")
+    ("metric-refresh", value(&metric_refresh)->default_value(4),
+     "how many process list updates reuse pss/uss values before reading them again")
+    ("state-cache", value(&use_state_cache)->default_value(true),
+     "keep last process list in $XDG_RUNTIME_DIR to show it right after restart")
+    ("numa", value(&use_numa)->default_value(true),
+     "show per NUMA node memory usage, only on machines with more than one node");
 
     args.parse(argc, argv);
     if (args.help()) {
@@ -31,6 +68,25 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    metric = parse_memory_metric(metric_name);
+
+    if (!icon_map_path.empty()) {
+        icons.load(icon_map_path);
+    }
+
+    if (use_state_cache) {
+        state_path = nwc::state_cache_path();
+    }
+
+    if (use_numa) {
+        detect_numa_nodes();
+    }
+
+    // with --once there is no later refresh, so stale snapshot would be the only output
+    if (!state_path.empty() && args.indefinite()) {
+        restore_process_list();
+    }
+
     do {
         loop();
 
@@ -116,6 +172,113 @@ auto load_current_memory_information() {
     return info;
 }
 
+struct numa_node_info {
+    int node{};
+    std::size_t ram_max = 0;
+    std::size_t ram_free = 0;
+    std::size_t ram_used = 0;
+    std::uint64_t numa_hit = 0;
+    std::uint64_t numa_miss = 0;
+    // rate is known only from second sample on, numastat counters are cumulative since boot
+    std::optional<double> miss_rate{};
+    bool sampled = false;
+};
+
+// Filled once at startup, stays empty on single node machines so per node files are never read
+static std::vector<numa_node_info> numa_nodes;
+
+std::vector<int> parse_node_list(const std::string &list) {
+    std::vector<int> nodes;
+
+    std::size_t pos = 0;
+    while (pos < list.size()) {
+        auto next = list.find(',', pos);
+        if (next == std::string::npos) {
+            next = list.size();
+        }
+
+        auto range = list.substr(pos, next - pos);
+        auto dash = range.find('-');
+        int first = std::stoi(range);
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int node = first; node <= last; ++node) {
+            nodes.push_back(node);
+        }
+
+        pos = next + 1;
+    }
+
+    return nodes;
+}
+
+void detect_numa_nodes() {
+    std::ifstream file("/sys/devices/system/node/has_memory");
+    if (!file.is_open()) {
+        return;
+    }
+
+    std::string line;
+    if (!std::getline(file, line) || line.empty()) {
+        return;
+    }
+
+    auto nodes = parse_node_list(line);
+    if (nodes.size() < 2) {
+        return;
+    }
+
+    for (auto node: nodes) {
+        numa_nodes.push_back(numa_node_info{.node = node});
+    }
+}
+
+void load_numa_information() {
+    for (auto &info: numa_nodes) {
+        auto const node_path = std::format("/sys/devices/system/node/node{}/", info.node);
+
+        std::ifstream meminfo(node_path + "meminfo");
+        if (meminfo.is_open()) {
+            std::string line;
+            while (std::getline(meminfo, line)) {
+                // lines look like "Node 0 MemTotal:       16336340 kB"
+                if (auto pos = line.find("MemTotal:"); pos != std::string::npos) {
+                    info.ram_max = std::stoul(line.substr(pos + 9)) * 1024;
+                }
+                if (auto pos = line.find("MemFree:"); pos != std::string::npos) {
+                    info.ram_free = std::stoul(line.substr(pos + 8)) * 1024;
+                }
+                if (auto pos = line.find("MemUsed:"); pos != std::string::npos) {
+                    info.ram_used = std::stoul(line.substr(pos + 8)) * 1024;
+                }
+            }
+        }
+
+        std::ifstream numastat(node_path + "numastat");
+        if (numastat.is_open()) {
+            std::uint64_t numa_hit = info.numa_hit, numa_miss = info.numa_miss;
+
+            std::string line;
+            while (std::getline(numastat, line)) {
+                if (line.starts_with("numa_hit ")) {
+                    numa_hit = std::stoull(line.substr(9));
+                }
+                if (line.starts_with("numa_miss ")) {
+                    numa_miss = std::stoull(line.substr(10));
+                }
+            }
+
+            if (info.sampled) {
+                auto const hits = numa_hit - info.numa_hit;
+                auto const misses = numa_miss - info.numa_miss;
+                info.miss_rate = hits + misses > 0 ? 100.0 * misses / (hits + misses) : 0;
+            }
+            info.numa_hit = numa_hit;
+            info.numa_miss = numa_miss;
+            info.sampled = true;
+        }
+    }
+}
+
 std::string get_text_from_info(const mem_info &info) {
     std::string icon = "\uf538";
     std::string current_usage = convert_bytes_to_human_readable(info.ram_used);
@@ -137,42 +300,14 @@ struct process_info {
     std::string name{}, cmd{};
     std::size_t memory{}, process_group_memory{};
     std::string icon{"*"};
-};
-
-std::map<std::string, std::string> icon_map = {
-    {"firefox", "\uf269"},
-    {"firefox-bin", "\uf269"},
-    {"webstorm", "\uf121"},
-    {"clion", "\ue61d"},
-    {"clangd", "\ue61d"},
-    {"Rider.Backend", "\uf121"},
-    {"systemd", "\uf4fe"},
-    {"systemd-journald", "\uf4fe"},
-    {"sddm", "\uf390"},
-    {"sddm-helper", "\uf390"},
-    {"Hyprland", "\uf359"},
-    {"xdg-desktop-portal-hyprland", "\uf359"},
-    {"hyprpaper", "\uf359"},
-    {"waybar", "\uf2d1"},
-    {"bash", "\uf120"},
-    {"sh", "\uf120"},
-    {"kitty", "\uf6be"},
-    {"dropbox", "\ue707"},
-    {"dockerd", "\ue7b0"},
-    {"containerd", "\ue7b0"},
-    {"keepassxc", "\uf033e"},
-    {"nodejs", "\ued0d"},
-    {"pnpm", "\ue865"},
-    {"Xorg", "\uf369"},
-    {"python", "\ue73c"},
-    {"python3", "\ue73c"},
-    {"nm-applet", "\uef09"},
+    // memory (or part of group memory) is RSS, process was not sampled or smaps_rollup was not readable
+    bool rss_fallback{}, group_rss_fallback{};
+    bool smaps_checked{};
 };
 
 void detect_icon_from_process(process_info &info) {
-    auto it = icon_map.find(info.name);
-    if (it != icon_map.end()) {
-        info.icon = it->second;
+    if (auto icon = icons.find(info.name)) {
+        info.icon = *icon;
     }
 }
 
@@ -224,6 +359,119 @@ std::optional<process_info> get_process_info(int pid) {
     return info;
 }
 
+memory_metric parse_memory_metric(std::string_view name) {
+    if (name == "rss") {
+        return memory_metric::rss;
+    }
+    if (name == "pss") {
+        return memory_metric::pss;
+    }
+    if (name == "uss") {
+        return memory_metric::uss;
+    }
+
+    throw std::runtime_error(std::format("unknown memory metric: {}", name));
+}
+
+std::optional<std::size_t> read_smaps_rollup(int pid) {
+    std::ifstream file("/proc/" + std::to_string(pid) + "/smaps_rollup");
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+
+    std::size_t pss = 0, private_clean = 0, private_dirty = 0;
+    bool found = false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.starts_with("Pss:")) {
+            pss = std::stoul(line.substr(4));
+            found = true;
+        }
+        if (line.starts_with("Private_Clean:")) {
+            private_clean = std::stoul(line.substr(14));
+        }
+        if (line.starts_with("Private_Dirty:")) {
+            private_dirty = std::stoul(line.substr(14));
+        }
+    }
+
+    // kernel threads have empty smaps_rollup
+    if (!found) {
+        return std::nullopt;
+    }
+
+    if (metric == memory_metric::uss) {
+        return (private_clean + private_dirty) * 1024;
+    }
+
+    return pss * 1024;
+}
+
+struct smaps_sample {
+    std::string name{};
+    // nullopt when smaps_rollup is not readable (other user's process), so it is not retried every update
+    std::optional<std::size_t> memory{};
+    unsigned generation{};
+};
+
+static std::unordered_map<int, smaps_sample> smaps_cache;
+static unsigned smaps_generation = 0;
+
+// Resolves PSS/USS of a single process, from cache if it's fresh enough
+void sample_smaps_metric(process_info &process, unsigned refresh) {
+    auto cached = smaps_cache.find(process.pid);
+    if (cached == smaps_cache.end() || cached->second.name != process.name ||
+        smaps_generation - cached->second.generation >= refresh) {
+        cached = smaps_cache.insert_or_assign(process.pid, smaps_sample{
+                                                  process.name, read_smaps_rollup(process.pid), smaps_generation
+                                              }).first;
+    }
+
+    process.smaps_checked = true;
+    if (cached->second.memory) {
+        process.memory = *cached->second.memory;
+        process.rss_fallback = false;
+    }
+}
+
+// Replaces RSS with PSS/USS for processes that end up in the top process list. RSS is an upper bound
+// of PSS/USS, so sampling continues until every process in the top list was checked: anything left
+// unchecked has RSS not bigger than the smallest displayed value and could not take its place.
+// Every other process keeps RSS and is flagged, so groups containing it are shown as partially RSS.
+// Reading smaps_rollup is expensive, so values are reused for `metric_refresh` process list updates.
+void apply_smaps_metric(std::vector<process_info> &processes) {
+    smaps_generation++;
+
+    for (auto &process: processes) {
+        process.rss_fallback = process.memory > 0;
+    }
+
+    const auto refresh = static_cast<unsigned>(std::max(metric_refresh, 1));
+    const auto count = std::min<std::size_t>(top_process_count, processes.size());
+
+    bool sampled = true;
+    while (sampled) {
+        sampled = false;
+
+        std::partial_sort(processes.begin(), processes.begin() + count, processes.end(),
+                          [](const auto &a, const auto &b) {
+                              return a.memory > b.memory;
+                          });
+
+        for (std::size_t it = 0; it < count; ++it) {
+            if (!processes[it].smaps_checked) {
+                sample_smaps_metric(processes[it], refresh);
+                sampled = true;
+            }
+        }
+    }
+
+    std::erase_if(smaps_cache, [refresh](const auto &entry) {
+        return smaps_generation - entry.second.generation >= refresh;
+    });
+}
+
 void calculate_process_group(std::vector<process_info> &processes) {
     int move = 0;
 
@@ -244,17 +492,70 @@ void calculate_process_group(std::vector<process_info> &processes) {
 
             parent_ptr->process_group_memory += process.memory;
             parent_ptr->memory += process.memory;
+            parent_ptr->group_rss_fallback |= process.rss_fallback;
+            parent_ptr->rss_fallback |= process.rss_fallback;
             process.memory = 0;
             move++;
         }
     } while (move > 0);
 }
 
-static auto last_update_time = std::chrono::system_clock::now();
+static auto process_snapshot = nwc::state_snapshot{.last_update = std::chrono::system_clock::now()};
 static auto generated_tooltip = std::string{};
+static unsigned iteration = 0;
+
+void render_process_list() {
+    std::string top_processes{};
+    for (auto const &process: process_snapshot.processes) {
+        top_processes += std::format(" {} {}: <b>{}</b> ({}{})\n",
+                                     process.icon,
+                                     process.pid,
+                                     process.name,
+                                     convert_bytes_to_human_readable(process.memory),
+                                     process.rss_fallback ? ", RSS" : "");
+    }
+
+    std::string top_process_groups{};
+    for (auto const &process: process_snapshot.groups) {
+        top_process_groups += std::format(" {} {}: <b>{}</b> ({}{})\n",
+                                          process.icon,
+                                          process.pid,
+                                          process.name,
+                                          convert_bytes_to_human_readable(process.memory),
+                                          process.rss_fallback ? ", partially RSS" : "");
+    }
+
+    std::string metric_label{};
+    if (metric != memory_metric::rss) {
+        metric_label = metric == memory_metric::pss ? " (PSS)" : " (USS)";
+    }
+
+    generated_tooltip = std::format("<b>Top processes</b>{}\n{}\n<b>Top process groups</b>{}\n{}\n",
+                                    metric_label, top_processes, metric_label, top_process_groups);
+}
+
+void restore_process_list() {
+    auto snapshot = nwc::load_state(state_path);
+    if (!snapshot || snapshot->metric != static_cast<std::uint32_t>(metric) ||
+        snapshot->top_process_count != static_cast<std::uint32_t>(top_process_count) ||
+        snapshot->top_group_count != static_cast<std::uint32_t>(top_group_count)) {
+        return;
+    }
+
+    process_snapshot = std::move(*snapshot);
+    render_process_list();
+
+    // first line shows restored list, fresh one is generated on the next tick
+    iteration = process_list_refresh_period - 1;
+}
 
 void update_process_list() {
-    last_update_time = std::chrono::system_clock::now();
+    process_snapshot.last_update = std::chrono::system_clock::now();
+    process_snapshot.metric = static_cast<std::uint32_t>(metric);
+    process_snapshot.top_process_count = static_cast<std::uint32_t>(top_process_count);
+    process_snapshot.top_group_count = static_cast<std::uint32_t>(top_group_count);
+    process_snapshot.processes.clear();
+    process_snapshot.groups.clear();
 
     std::vector<process_info> processes;
     for (const auto &entry: std::filesystem::directory_iterator("/proc")) {
@@ -281,17 +582,20 @@ void update_process_list() {
         return a.memory > b.memory;
     });
 
-    std::string top_processes{};
+    if (metric != memory_metric::rss) {
+        apply_smaps_metric(processes);
+        std::sort(processes.begin(), processes.end(), [](const auto &a, const auto &b) {
+            return a.memory > b.memory;
+        });
+    }
+
     for (auto it = 0; it < std::min<unsigned>(top_process_count, processes.size()); ++it) {
         auto const &process = processes[it];
-        top_processes += std::format(" {} {}: <b>{}</b> ({})\n",
-                                     process.icon,
-                                     process.pid,
-                                     process.name,
-                                     convert_bytes_to_human_readable(process.memory));
+        process_snapshot.processes.push_back({
+            process.pid, process.memory, process.name, process.icon, process.rss_fallback
+        });
     }
 
-    std::string top_process_groups{};
     calculate_process_group(processes);
     std::sort(processes.begin(), processes.end(), [](const auto &a, const auto &b) {
         return a.process_group_memory > b.process_group_memory;
@@ -302,19 +606,20 @@ void update_process_list() {
 
     for (auto it = 0; it < std::min<unsigned>(top_group_count, processes.size()); ++it) {
         auto const &process = processes[it];
-        top_process_groups += std::format(" {} {}: <b>{}</b> ({})\n",
-                                          process.icon,
-                                          process.pid,
-                                          process.name,
-                                          convert_bytes_to_human_readable(process.process_group_memory));
+        process_snapshot.groups.push_back({
+            process.pid, process.process_group_memory, process.name, process.icon, process.group_rss_fallback
+        });
     }
 
-    generated_tooltip = std::format("<b>Top processes</b>\n{}\n<b>Top process groups</b>\n{}\n", top_processes,
-                                    top_process_groups);
+    render_process_list();
+
+    if (!state_path.empty()) {
+        nwc::save_state(state_path, process_snapshot);
+    }
 }
 
 std::string generate_tooltip_from(unsigned count) {
-    if (count % 15 == 0) {
+    if (count % process_list_refresh_period == 0) {
         update_process_list();
     }
 
@@ -351,20 +656,36 @@ std::string get_tooltip_from_info(const mem_info &info, unsigned count) {
                            convert_bytes_to_human_readable(info.buffer_current)
     );
 
-    tooltip += std::format("<b>SWAP</b>: {}/{}\n\n", convert_bytes_to_human_readable(info.swap_current),
+    tooltip += std::format("<b>SWAP</b>: {}/{}\n", convert_bytes_to_human_readable(info.swap_current),
                            convert_bytes_to_human_readable(info.swap_max));
 
+    for (const auto &node: numa_nodes) {
+        std::string miss_rate{};
+        if (node.miss_rate) {
+            miss_rate = std::format(" | miss: {:.2f}%", *node.miss_rate);
+        }
+
+        tooltip += std::format("<b>Node {}</b>: {}/{} (free: {}{})\n",
+                               node.node,
+                               convert_bytes_to_human_readable(node.ram_used),
+                               convert_bytes_to_human_readable(node.ram_max),
+                               convert_bytes_to_human_readable(node.ram_free),
+                               miss_rate);
+    }
+
+    tooltip += "\n";
+
     tooltip += generate_tooltip_from(count);
 
-    tooltip += std::format("<i>Last updated: {}</i> | <i>Next update in: {}s</i>", last_update_time, 15 - (count % 15));
+    tooltip += std::format("<i>Last updated: {}</i> | <i>Next update in: {}s</i>", process_snapshot.last_update,
+                           process_list_refresh_period - (count % process_list_refresh_period));
 
     return tooltip;
 }
 
-static unsigned iteration = 0;
-
 void loop() {
     auto const info = load_current_memory_information();
+    load_numa_information();
 
     std::string text = get_text_from_info(info);
     std::string alt_text = get_alt_text_from_info(info);
@@ -382,5 +703,5 @@ void loop() {
     );
 
     std::println("{}", serialize(jv));
-    std::flush(std::cout);
+    std::fflush(stdout);
 }
@@ -0,0 +1,239 @@
+#include "./state-cache.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace nwc {
+    namespace {
+        // File layout: header, process rows, group rows, string pool with deduplicated names and icons
+        constexpr std::array<char, 8> state_magic{'N', 'W', 'C', 'M', 'E', 'M', 'S', 'T'};
+        constexpr std::uint32_t state_version = 2;
+
+        struct file_header {
+            std::array<char, 8> magic{};
+            std::uint32_t version{};
+            std::uint32_t metric{};
+            std::int64_t last_update{};
+            std::uint32_t process_count{};
+            std::uint32_t group_count{};
+            std::uint32_t strings_size{};
+            std::uint32_t top_process_count{};
+            std::uint32_t top_group_count{};
+            std::uint32_t reserved{};
+        };
+
+        struct file_row {
+            std::int32_t pid{};
+            std::uint32_t name_offset{}, name_length{};
+            std::uint32_t icon_offset{}, icon_length{};
+            std::uint32_t flags{};
+            std::uint64_t memory{};
+        };
+
+        static_assert(std::is_trivially_copyable_v<file_header> && sizeof(file_header) == 48);
+        static_assert(std::is_trivially_copyable_v<file_row> && sizeof(file_row) == 32);
+
+        constexpr std::uint32_t row_rss_fallback = 1;
+
+        class string_pool {
+        public:
+            std::uint32_t intern(const std::string &value) {
+                auto [it, inserted] = offsets_.try_emplace(value, static_cast<std::uint32_t>(data_.size()));
+                if (inserted) {
+                    data_ += value;
+                }
+                return it->second;
+            }
+
+            [[nodiscard]] const std::string &data() const noexcept {
+                return data_;
+            }
+
+        private:
+            std::unordered_map<std::string, std::uint32_t> offsets_;
+            std::string data_;
+        };
+
+        file_row make_row(const state_row &row, string_pool &strings) {
+            return file_row{
+                .pid = row.pid,
+                .name_offset = strings.intern(row.name),
+                .name_length = static_cast<std::uint32_t>(row.name.size()),
+                .icon_offset = strings.intern(row.icon),
+                .icon_length = static_cast<std::uint32_t>(row.icon.size()),
+                .flags = row.rss_fallback ? row_rss_fallback : 0,
+                .memory = row.memory,
+            };
+        }
+
+        std::optional<std::vector<state_row>> read_rows(const file_row *rows, std::uint32_t count,
+                                                        std::string_view strings) {
+            std::vector<state_row> result;
+            result.reserve(count);
+
+            for (std::uint32_t it = 0; it < count; ++it) {
+                file_row row;
+                std::memcpy(&row, rows + it, sizeof(row));
+
+                if (row.name_offset > strings.size() || row.name_length > strings.size() - row.name_offset ||
+                    row.icon_offset > strings.size() || row.icon_length > strings.size() - row.icon_offset) {
+                    return std::nullopt;
+                }
+
+                result.push_back(state_row{
+                    .pid = row.pid,
+                    .memory = row.memory,
+                    .name = std::string{strings.substr(row.name_offset, row.name_length)},
+                    .icon = std::string{strings.substr(row.icon_offset, row.icon_length)},
+                    .rss_fallback = (row.flags & row_rss_fallback) != 0,
+                });
+            }
+
+            return result;
+        }
+
+        bool write_all(int fd, const void *data, std::size_t size) {
+            const auto *bytes = static_cast<const char *>(data);
+            while (size > 0) {
+                const auto written = write(fd, bytes, size);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+
+                bytes += written;
+                size -= static_cast<std::size_t>(written);
+            }
+
+            return true;
+        }
+    }
+
+    std::string state_cache_path() {
+        const char *runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+        if (runtime_dir == nullptr || *runtime_dir == '\0') {
+            return {};
+        }
+
+        return std::format("{}/{}.state", runtime_dir, APP_NAME);
+    }
+
+    std::optional<state_snapshot> load_state(const std::string &path) {
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return std::nullopt;
+        }
+
+        struct stat st = {};
+        if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(file_header))) {
+            close(fd);
+            return std::nullopt;
+        }
+
+        const auto size = static_cast<std::size_t>(st.st_size);
+        void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            return std::nullopt;
+        }
+
+        auto unmap = [size](void *ptr) { munmap(ptr, size); };
+        std::unique_ptr<void, decltype(unmap)> mapped_cleanup_ptr(mapped, unmap);
+
+        const auto *bytes = static_cast<const char *>(mapped);
+
+        file_header header;
+        std::memcpy(&header, bytes, sizeof(header));
+        if (header.magic != state_magic || header.version != state_version) {
+            return std::nullopt;
+        }
+
+        const std::size_t rows_size = (static_cast<std::size_t>(header.process_count) + header.group_count) *
+                                      sizeof(file_row);
+        if (sizeof(file_header) + rows_size + header.strings_size != size) {
+            return std::nullopt;
+        }
+
+        const auto *rows = reinterpret_cast<const file_row *>(bytes + sizeof(file_header));
+        const std::string_view strings{bytes + sizeof(file_header) + rows_size, header.strings_size};
+
+        auto processes = read_rows(rows, header.process_count, strings);
+        auto groups = read_rows(rows + header.process_count, header.group_count, strings);
+        if (!processes || !groups) {
+            return std::nullopt;
+        }
+
+        return state_snapshot{
+            .last_update = std::chrono::system_clock::time_point{std::chrono::seconds{header.last_update}},
+            .metric = header.metric,
+            .top_process_count = header.top_process_count,
+            .top_group_count = header.top_group_count,
+            .processes = std::move(*processes),
+            .groups = std::move(*groups),
+        };
+    }
+
+    bool save_state(const std::string &path, const state_snapshot &snapshot) {
+        string_pool strings;
+        std::vector<file_row> rows;
+        rows.reserve(snapshot.processes.size() + snapshot.groups.size());
+
+        for (const auto &row: snapshot.processes) {
+            rows.push_back(make_row(row, strings));
+        }
+        for (const auto &row: snapshot.groups) {
+            rows.push_back(make_row(row, strings));
+        }
+
+        const file_header header{
+            .magic = state_magic,
+            .version = state_version,
+            .metric = snapshot.metric,
+            .last_update = std::chrono::duration_cast<std::chrono::seconds>(
+                snapshot.last_update.time_since_epoch()).count(),
+            .process_count = static_cast<std::uint32_t>(snapshot.processes.size()),
+            .group_count = static_cast<std::uint32_t>(snapshot.groups.size()),
+            .strings_size = static_cast<std::uint32_t>(strings.data().size()),
+            .top_process_count = snapshot.top_process_count,
+            .top_group_count = snapshot.top_group_count,
+        };
+
+        // every waybar output runs its own helper, so each writer needs its own temporary file
+        std::string temporary_path = path + ".XXXXXX";
+        const int fd = mkstemp(temporary_path.data());
+        if (fd < 0) {
+            return false;
+        }
+
+        const bool written = write_all(fd, &header, sizeof(header)) &&
+                             write_all(fd, rows.data(), rows.size() * sizeof(file_row)) &&
+                             write_all(fd, strings.data().data(), strings.data().size());
+        if (close(fd) != 0 || !written) {
+            unlink(temporary_path.c_str());
+            return false;
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(temporary_path, path, ec);
+        if (ec) {
+            unlink(temporary_path.c_str());
+            return false;
+        }
+
+        return true;
+    }
+}
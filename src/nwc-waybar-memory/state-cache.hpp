@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace nwc {
+    struct state_row {
+        int pid{};
+        std::size_t memory{};
+        std::string name{}, icon{};
+        bool rss_fallback{};
+    };
+
+    // Last process list shown in tooltip, persisted between restarts of the helper
+    struct state_snapshot {
+        std::chrono::system_clock::time_point last_update{};
+        std::uint32_t metric{};
+        // display limits the snapshot was made with, helpers started with other limits ignore it
+        std::uint32_t top_process_count{}, top_group_count{};
+        std::vector<state_row> processes{}, groups{};
+    };
+
+    // Returns empty string when $XDG_RUNTIME_DIR is not set
+    [[nodiscard]] std::string state_cache_path();
+
+    // Maps state file, returns nullopt when it is missing or malformed
+    [[nodiscard]] std::optional<state_snapshot> load_state(const std::string &path);
+
+    // Atomically replaces state file, returns false on failure
+    bool save_state(const std::string &path, const state_snapshot &snapshot);
+}
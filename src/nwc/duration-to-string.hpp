@@ -52,4 +52,23 @@ namespace nwc {
         }
         return "0s";
     }
+
+    // Time after which duration_to_string(duration + result, strip_seconds) gives different text
+    template<typename T, typename R>
+    std::chrono::seconds duration_to_string_next_change(std::chrono::duration<T, R> duration,
+                                                        bool strip_seconds = false) {
+        using namespace std;
+
+        const auto elapsed = duration_cast<chrono::seconds>(duration);
+        if (!strip_seconds || elapsed < chrono::minutes{1}) {
+            return chrono::seconds{1};
+        }
+
+        // months and years are not whole minutes long, so they can roll over between minute boundaries
+        const auto until_minute = chrono::seconds{chrono::minutes{1}} - elapsed % chrono::minutes{1};
+        const auto until_month = chrono::seconds{chrono::months{1}} - elapsed % chrono::months{1};
+        const auto until_year = chrono::seconds{chrono::years{1}} - elapsed % chrono::years{1};
+
+        return min({until_minute, until_month, until_year});
+    }
 }
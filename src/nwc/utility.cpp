@@ -1,7 +1,27 @@
 #include "./utility.hpp"
 
+#include <cerrno>
+#include <stdexcept>
 #include <unistd.h>
 
 void nwc::sleep(int miliseconds) {
     usleep(miliseconds * 1000);
 }
+
+std::chrono::nanoseconds nwc::clock_now(clockid_t clock) {
+    timespec ts = {};
+    if (clock_gettime(clock, &ts) != 0) {
+        throw std::runtime_error("clock_gettime failed");
+    }
+
+    return std::chrono::seconds{ts.tv_sec} + std::chrono::nanoseconds{ts.tv_nsec};
+}
+
+void nwc::sleep_until(clockid_t clock, std::chrono::nanoseconds deadline) {
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(deadline.count() / 1000000000);
+    ts.tv_nsec = static_cast<long>(deadline.count() % 1000000000);
+
+    while (clock_nanosleep(clock, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+}
@@ -1,5 +1,14 @@
 #pragma once
 
+#include <chrono>
+#include <ctime>
+
 namespace nwc {
     void sleep(int miliseconds);
-}
\ No newline at end of file
+
+    // Current time of given clock (CLOCK_REALTIME, CLOCK_BOOTTIME, ...)
+    [[nodiscard]] std::chrono::nanoseconds clock_now(clockid_t clock);
+
+    // Sleeps until absolute deadline measured on given clock
+    void sleep_until(clockid_t clock, std::chrono::nanoseconds deadline);
+}